@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <format>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ORDERBOOK_X86_KERNELS
+#endif
+
+#include "BatchValidator.h"
+
+// The vector kernels load sides as 32 bit lanes.
+static_assert(sizeof(Side) == sizeof(std::int32_t));
+
+namespace
+{
+    // Everything the kernels check, resolved once per batch so each kernel runs the same compares per order.
+    struct Bands
+    {
+        Price buyLow_;
+        Price buyHigh_;
+        Price sellLow_;
+        Price sellHigh_;
+        Quantity maxQuantity_;
+        std::int64_t maxNotional_;
+    };
+
+    Price ClampToPrice(std::int64_t value)
+    {
+        return static_cast<Price>(std::clamp<std::int64_t>(value, std::numeric_limits<Price>::min(), std::numeric_limits<Price>::max()));
+    }
+
+    Bands MakeBands(const RiskLimits& limits, std::optional<Price> bestBid, std::optional<Price> bestAsk)
+    {
+        Bands bands{ std::numeric_limits<Price>::min(), std::numeric_limits<Price>::max(),
+            std::numeric_limits<Price>::min(), std::numeric_limits<Price>::max(),
+            limits.maxQuantity_, limits.maxNotional_ };
+
+        // Buys are collared around the price they would trade at (best ask), sells around the best bid. Fall back to the other side if one is empty.
+        const std::optional<Price> buyReference = bestAsk.has_value() ? bestAsk : bestBid;
+        const std::optional<Price> sellReference = bestBid.has_value() ? bestBid : bestAsk;
+
+        if (buyReference.has_value())
+        {
+            bands.buyLow_ = ClampToPrice(static_cast<std::int64_t>(*buyReference) - limits.priceCollar_);
+            bands.buyHigh_ = ClampToPrice(static_cast<std::int64_t>(*buyReference) + limits.priceCollar_);
+        }
+
+        if (sellReference.has_value())
+        {
+            bands.sellLow_ = ClampToPrice(static_cast<std::int64_t>(*sellReference) - limits.priceCollar_);
+            bands.sellHigh_ = ClampToPrice(static_cast<std::int64_t>(*sellReference) + limits.priceCollar_);
+        }
+
+        return bands;
+    }
+
+    bool AcceptScalar(const Bands& bands, Side side, Price price, Quantity quantity)
+    {
+        const Price low = side == Side::Buy ? bands.buyLow_ : bands.sellLow_;
+        const Price high = side == Side::Buy ? bands.buyHigh_ : bands.sellHigh_;
+
+        // Price is positive here, so the product fits in 63 bits.
+        const auto notional = static_cast<std::int64_t>(static_cast<std::uint64_t>(static_cast<std::uint32_t>(price)) * quantity);
+
+        return price > 0 && price >= low && price <= high &&
+            quantity != 0 && quantity <= bands.maxQuantity_ &&
+            notional <= bands.maxNotional_;
+    }
+
+    void ValidateScalar(const Bands& bands, const OrderBatch& batch, std::size_t begin, std::uint8_t* accept)
+    {
+        const auto& sides = batch.GetSides();
+        const auto& prices = batch.GetPrices();
+        const auto& quantities = batch.GetQuantities();
+
+        for (std::size_t i = begin; i < batch.Size(); ++i)
+            accept[i] = AcceptScalar(bands, sides[i], prices[i], quantities[i]);
+    }
+
+    // Rejects every order whose id already appeared earlier in the batch, whether or not that earlier order passed the other checks.
+    // One pass over an open addressing table of batch indices sized to at least twice the batch, so O(n) for any batch size.
+    void RejectDuplicates(const OrderBatch& batch, std::uint8_t* accept)
+    {
+        const OrderId* orderIds = batch.GetOrderIds().data();
+        if (batch.Size() < 2)
+            return;
+
+        const std::size_t capacity = std::bit_ceil(2 * batch.Size());
+        const int shift = std::numeric_limits<std::uint64_t>::digits - std::countr_zero(capacity);
+
+        // Slots hold index + 1 of the first order seen with an id, 0 is empty.
+        std::vector<std::size_t> slots(capacity);
+        for (std::size_t i = 0; i < batch.Size(); ++i)
+        {
+            // Fibonacci hashing, the high bits of the product are well mixed even for sequential ids.
+            std::size_t slot = static_cast<std::size_t>((static_cast<std::uint64_t>(orderIds[i]) * 0x9E3779B97F4A7C15ull) >> shift);
+            while (slots[slot] != 0 && orderIds[slots[slot] - 1] != orderIds[i])
+                slot = (slot + 1) & (capacity - 1);
+
+            if (slots[slot] != 0)
+                accept[i] = 0;
+            else
+                slots[slot] = i + 1;
+        }
+    }
+
+#ifdef ORDERBOOK_X86_KERNELS
+
+    __attribute__((target("sse4.2")))
+    void ValidateSse(const Bands& bands, const OrderBatch& batch, std::uint8_t* accept)
+    {
+        const Side* sides = batch.GetSides().data();
+        const Price* prices = batch.GetPrices().data();
+        const Quantity* quantities = batch.GetQuantities().data();
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i buy = _mm_set1_epi32(static_cast<std::int32_t>(Side::Buy));
+        const __m128i buyLow = _mm_set1_epi32(bands.buyLow_);
+        const __m128i buyHigh = _mm_set1_epi32(bands.buyHigh_);
+        const __m128i sellLow = _mm_set1_epi32(bands.sellLow_);
+        const __m128i sellHigh = _mm_set1_epi32(bands.sellHigh_);
+        const __m128i maxQuantity = _mm_set1_epi32(static_cast<std::int32_t>(bands.maxQuantity_));
+        const __m128i maxNotional = _mm_set1_epi64x(bands.maxNotional_);
+
+        constexpr std::size_t Lanes = 4;
+        std::size_t i = 0;
+        for (; i + Lanes <= batch.Size(); i += Lanes)
+        {
+            const __m128i side = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sides + i));
+            const __m128i price = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prices + i));
+            const __m128i quantity = _mm_loadu_si128(reinterpret_cast<const __m128i*>(quantities + i));
+
+            const __m128i isBuy = _mm_cmpeq_epi32(side, buy);
+            const __m128i low = _mm_blendv_epi8(sellLow, buyLow, isBuy);
+            const __m128i high = _mm_blendv_epi8(sellHigh, buyHigh, isBuy);
+
+            __m128i accepted = _mm_cmpgt_epi32(price, zero);
+            accepted = _mm_andnot_si128(_mm_cmpgt_epi32(low, price), accepted);
+            accepted = _mm_andnot_si128(_mm_cmpgt_epi32(price, high), accepted);
+            accepted = _mm_andnot_si128(_mm_cmpeq_epi32(quantity, zero), accepted);
+            accepted = _mm_and_si128(_mm_cmpeq_epi32(_mm_min_epu32(quantity, maxQuantity), quantity), accepted);
+
+            // 32 x 32 -> 64 bit products of the even lanes, then of the odd lanes shifted down, recombined into one mask per lane.
+            const __m128i evenNotional = _mm_mul_epu32(price, quantity);
+            const __m128i oddNotional = _mm_mul_epu32(_mm_srli_epi64(price, 32), _mm_srli_epi64(quantity, 32));
+            const __m128i overNotional = _mm_blend_epi16(_mm_cmpgt_epi64(evenNotional, maxNotional), _mm_cmpgt_epi64(oddNotional, maxNotional), 0xCC);
+            accepted = _mm_andnot_si128(overNotional, accepted);
+
+            const int bits = _mm_movemask_ps(_mm_castsi128_ps(accepted));
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+                accept[i + lane] = (bits >> lane) & 1;
+        }
+
+        ValidateScalar(bands, batch, i, accept);
+    }
+
+    __attribute__((target("avx2")))
+    void ValidateAvx2(const Bands& bands, const OrderBatch& batch, std::uint8_t* accept)
+    {
+        const Side* sides = batch.GetSides().data();
+        const Price* prices = batch.GetPrices().data();
+        const Quantity* quantities = batch.GetQuantities().data();
+
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i buy = _mm256_set1_epi32(static_cast<std::int32_t>(Side::Buy));
+        const __m256i buyLow = _mm256_set1_epi32(bands.buyLow_);
+        const __m256i buyHigh = _mm256_set1_epi32(bands.buyHigh_);
+        const __m256i sellLow = _mm256_set1_epi32(bands.sellLow_);
+        const __m256i sellHigh = _mm256_set1_epi32(bands.sellHigh_);
+        const __m256i maxQuantity = _mm256_set1_epi32(static_cast<std::int32_t>(bands.maxQuantity_));
+        const __m256i maxNotional = _mm256_set1_epi64x(bands.maxNotional_);
+
+        constexpr std::size_t Lanes = 8;
+        std::size_t i = 0;
+        for (; i + Lanes <= batch.Size(); i += Lanes)
+        {
+            const __m256i side = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sides + i));
+            const __m256i price = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices + i));
+            const __m256i quantity = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(quantities + i));
+
+            const __m256i isBuy = _mm256_cmpeq_epi32(side, buy);
+            const __m256i low = _mm256_blendv_epi8(sellLow, buyLow, isBuy);
+            const __m256i high = _mm256_blendv_epi8(sellHigh, buyHigh, isBuy);
+
+            __m256i accepted = _mm256_cmpgt_epi32(price, zero);
+            accepted = _mm256_andnot_si256(_mm256_cmpgt_epi32(low, price), accepted);
+            accepted = _mm256_andnot_si256(_mm256_cmpgt_epi32(price, high), accepted);
+            accepted = _mm256_andnot_si256(_mm256_cmpeq_epi32(quantity, zero), accepted);
+            accepted = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_min_epu32(quantity, maxQuantity), quantity), accepted);
+
+            // 32 x 32 -> 64 bit products of the even lanes, then of the odd lanes shifted down, recombined into one mask per lane.
+            const __m256i evenNotional = _mm256_mul_epu32(price, quantity);
+            const __m256i oddNotional = _mm256_mul_epu32(_mm256_srli_epi64(price, 32), _mm256_srli_epi64(quantity, 32));
+            const __m256i overNotional = _mm256_blend_epi32(_mm256_cmpgt_epi64(evenNotional, maxNotional), _mm256_cmpgt_epi64(oddNotional, maxNotional), 0xAA);
+            accepted = _mm256_andnot_si256(overNotional, accepted);
+
+            const int bits = _mm256_movemask_ps(_mm256_castsi256_ps(accepted));
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+                accept[i + lane] = (bits >> lane) & 1;
+        }
+
+        ValidateScalar(bands, batch, i, accept);
+    }
+
+#endif
+}
+
+BatchValidator::BatchValidator(RiskLimits limits)
+    : BatchValidator(limits, GetBestKernel())
+{ }
+
+BatchValidator::BatchValidator(RiskLimits limits, ValidationKernel kernel)
+    : limits_{ limits },
+    kernel_{ kernel }
+{
+    if (!IsSupported(kernel))
+        throw std::logic_error(std::format("Validation kernel ({}) is not supported on this CPU.\n", static_cast<int>(kernel)));
+}
+
+bool BatchValidator::IsSupported(ValidationKernel kernel)
+{
+    switch (kernel)
+    {
+    case ValidationKernel::Scalar:
+        return true;
+#ifdef ORDERBOOK_X86_KERNELS
+    case ValidationKernel::Sse:
+        return __builtin_cpu_supports("sse4.2");
+    case ValidationKernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+ValidationKernel BatchValidator::GetBestKernel()
+{
+    if (IsSupported(ValidationKernel::Avx2))
+        return ValidationKernel::Avx2;
+
+    if (IsSupported(ValidationKernel::Sse))
+        return ValidationKernel::Sse;
+
+    return ValidationKernel::Scalar;
+}
+
+AcceptMask BatchValidator::Validate(const OrderBatch& batch, std::optional<Price> bestBid, std::optional<Price> bestAsk) const
+{
+    const Bands bands = MakeBands(limits_, bestBid, bestAsk);
+    AcceptMask accept(batch.Size());
+
+    switch (kernel_)
+    {
+#ifdef ORDERBOOK_X86_KERNELS
+    case ValidationKernel::Avx2:
+        ValidateAvx2(bands, batch, accept.data());
+        break;
+    case ValidationKernel::Sse:
+        ValidateSse(bands, batch, accept.data());
+        break;
+#endif
+    default:
+        ValidateScalar(bands, batch, 0, accept.data());
+        break;
+    }
+
+    RejectDuplicates(batch, accept.data());
+
+    return accept;
+}
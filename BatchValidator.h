@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "Usings.h"
+#include "OrderBatch.h"
+#include "RiskLimits.h"
+
+// One entry per order of a batch, 1 if the order passed validation and 0 otherwise.
+using AcceptMask = std::vector<std::uint8_t>;
+
+// Instruction sets the validation kernels are compiled for. All of them produce identical accept masks.
+enum class ValidationKernel
+{
+    Scalar,
+    Sse,
+    Avx2,
+
+};
+
+// Screens a batch of candidate orders before any of them reach the book. An order is accepted if:
+//  - its price is positive and within the price collar of the opposite best price (the same side best price if the opposite side is empty,
+//    no collar if the book is empty),
+//  - its quantity is positive and at most the maximum quantity,
+//  - its notional is at most the maximum notional,
+//  - its id did not already appear earlier in the batch.
+class BatchValidator
+{
+public:
+    explicit BatchValidator(RiskLimits limits);
+    BatchValidator(RiskLimits limits, ValidationKernel kernel);
+
+    // Widest kernel the running CPU supports.
+    static ValidationKernel GetBestKernel();
+    static bool IsSupported(ValidationKernel kernel);
+
+    ValidationKernel GetKernel() const { return kernel_; }
+    const RiskLimits& GetLimits() const { return limits_; }
+
+    AcceptMask Validate(const OrderBatch& batch, std::optional<Price> bestBid, std::optional<Price> bestAsk) const;
+
+private:
+    RiskLimits limits_;
+    ValidationKernel kernel_;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <map>
+#include <functional>
+
+#include "Usings.h"
+#include "Side.h"
+#include "Order.h"
+#include "LevelQueue.h"
+
+// Compile time description of each side of the orderbook.
+// Every price comparison goes through Compare, so the Buy and Sell code paths are generated separately instead of branching on Side at runtime.
+template <Side S>
+struct SideTraits;
+
+template <>
+struct SideTraits<Side::Buy>
+{
+    // Bids in descending order (largest first)
+    using Compare = std::greater<Price>;
+    static constexpr Side Opposite = Side::Sell;
+};
+
+template <>
+struct SideTraits<Side::Sell>
+{
+    // Asks in ascending order (smallest first)
+    using Compare = std::less<Price>;
+    static constexpr Side Opposite = Side::Buy;
+};
+
+template <Side S>
+inline constexpr Side OppositeSide = SideTraits<S>::Opposite;
+
+// One half of the orderbook. Levels are stored best price first, so begin() is always the best level and rbegin() the worst.
+template <Side S>
+class BookSide
+{
+public:
+    using Compare = typename SideTraits<S>::Compare;
+    using Levels = std::map<Price, LevelQueue, Compare>;
+
+    bool Empty() const { return levels_.empty(); }
+    Price BestPrice() const { return levels_.begin()->first; }
+    Price WorstPrice() const { return levels_.rbegin()->first; }
+
+    Levels& GetLevels() { return levels_; }
+    const Levels& GetLevels() const { return levels_; }
+
+    // An order on this side at price trades against a resting contra order at contraPrice if contraPrice is at least as good as price.
+    // Buy: price >= contraPrice, Sell: price <= contraPrice.
+    static constexpr bool Crosses(Price price, Price contraPrice) { return !Compare{}(contraPrice, price); }
+
+    // A level on this side can be reached by a contra order limited at limit if the level is not worse than the limit.
+    static constexpr bool Reaches(Price levelPrice, Price limit) { return !Compare{}(limit, levelPrice); }
+
+    // Walk the levels from the best price towards limit and check if their cumulative quantity covers quantity.
+    bool HasDepth(Price limit, Quantity quantity) const
+    {
+        for (const auto& [levelPrice, level] : levels_)
+        {
+            if (!Reaches(levelPrice, limit))
+                break;
+
+            if (quantity <= level.GetQuantity())
+                return true;
+
+            quantity -= level.GetQuantity();
+        }
+
+        return false;
+    }
+
+    LevelQueue::iterator Add(const OrderPointer& order)
+    {
+        return levels_[order->GetPrice()].Push(order);
+    }
+
+    void Remove(Price price, LevelQueue::iterator location)
+    {
+        auto level = levels_.find(price);
+        level->second.Erase(location);
+
+        if (level->second.Empty())
+            levels_.erase(level);
+    }
+
+    QueuePosition GetQueuePosition(Price price, LevelQueue::const_iterator location) const
+    {
+        return levels_.at(price).GetQueuePosition(location);
+    }
+
+private:
+    Levels levels_;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Binary indexed tree over a fixed number of slots. Point updates and prefix sums are both O(log n).
+template <typename T>
+class FenwickTree
+{
+public:
+    explicit FenwickTree(std::size_t size = 0)
+        : tree_(size + 1)
+    { }
+
+    std::size_t Size() const { return tree_.size() - 1; }
+
+    void Add(std::size_t index, T delta)
+    {
+        for (++index; index < tree_.size(); index += index & (~index + 1))
+            tree_[index] += delta;
+    }
+
+    void Subtract(std::size_t index, T delta)
+    {
+        for (++index; index < tree_.size(); index += index & (~index + 1))
+            tree_[index] -= delta;
+    }
+
+    // Sum of the first count slots, [0, count).
+    T PrefixSum(std::size_t count) const
+    {
+        T sum{};
+        for (; count > 0; count &= count - 1)
+            sum += tree_[count];
+
+        return sum;
+    }
+
+    // Add zero valued slots at the end, keeping the existing values. Existing nodes cover the same ranges at any size, so only the new nodes
+    // whose range reaches back into the old slots need a value, and there are O(log n) of those.
+    void Grow(std::size_t size)
+    {
+        const std::size_t oldSize = Size();
+        const T total = PrefixSum(oldSize);
+
+        tree_.resize(size + 1, T{});
+        for (std::size_t index = oldSize + 1; index < tree_.size(); ++index)
+        {
+            const std::size_t rangeStart = index - (index & (~index + 1));
+            if (rangeStart < oldSize)
+                tree_[index] = total - PrefixSum(rangeStart);
+        }
+    }
+
+    // Rebuild the tree from a full set of slot values in O(n).
+    void Assign(const std::vector<T>& values)
+    {
+        tree_.assign(values.size() + 1, T{});
+        for (std::size_t index = 1; index < tree_.size(); ++index)
+        {
+            tree_[index] += values[index - 1];
+
+            const std::size_t parent = index + (index & (~index + 1));
+            if (parent < tree_.size())
+                tree_[parent] += tree_[index];
+        }
+    }
+
+private:
+    std::vector<T> tree_;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include "Usings.h"
+#include "Order.h"
+#include "FenwickTree.h"
+#include "QueuePosition.h"
+
+// Time priority queue of the orders resting at one price level.
+// Every order is given an increasing slot when it joins the level, and the count and remaining quantity of each slot are kept in Fenwick trees,
+// so the quantity ahead of any order is a prefix sum instead of a walk from the front of the level.
+class LevelQueue
+{
+public:
+    struct Entry
+    {
+        OrderPointer order_;
+        std::size_t slot_;
+    };
+
+    using Entries = std::list<Entry>;
+    using iterator = Entries::iterator;
+    using const_iterator = Entries::const_iterator;
+
+    bool Empty() const { return entries_.empty(); }
+    std::size_t Size() const { return entries_.size(); }
+    Quantity GetQuantity() const { return quantity_; }
+    const OrderPointer& Front() const { return entries_.front().order_; }
+
+    iterator Push(const OrderPointer& order)
+    {
+        if (nextSlot_ == counts_.Size())
+            Compact();
+
+        const std::size_t slot = nextSlot_++;
+        entries_.push_back(Entry{ order, slot });
+
+        counts_.Add(slot, 1);
+        quantities_.Add(slot, order->GetRemainingQuantity());
+        quantity_ += order->GetRemainingQuantity();
+
+        return std::prev(entries_.end());
+    }
+
+    // Fill the order at the front of the level. The front slot is never summed from the trees (see GetQueuePosition), so they are left alone.
+    void FillFront(Quantity quantity)
+    {
+        entries_.front().order_->Fill(quantity);
+        quantity_ -= quantity;
+    }
+
+    void PopFront()
+    {
+        quantity_ -= entries_.front().order_->GetRemainingQuantity();
+        entries_.pop_front();
+    }
+
+    void Erase(iterator location)
+    {
+        if (location == entries_.begin())
+        {
+            PopFront();
+            return;
+        }
+
+        const auto& [order, slot] = *location;
+
+        counts_.Subtract(slot, 1);
+        quantities_.Subtract(slot, order->GetRemainingQuantity());
+        quantity_ -= order->GetRemainingQuantity();
+
+        entries_.erase(location);
+    }
+
+    // Only the slots strictly between the front order and this one are summed from the trees, the front order's quantity is read from the order itself.
+    // Slots up to and including the front are never read, so filling or removing the front order (the whole matching loop) needs no tree updates.
+    QueuePosition GetQueuePosition(const_iterator location) const
+    {
+        if (location == entries_.begin())
+            return QueuePosition{ 0, 0 };
+
+        const auto& [front, frontSlot] = entries_.front();
+        const std::size_t afterFront = frontSlot + 1;
+
+        return QueuePosition{
+            counts_.PrefixSum(location->slot_) - counts_.PrefixSum(afterFront) + 1,
+            quantities_.PrefixSum(location->slot_) - quantities_.PrefixSum(afterFront) + front->GetRemainingQuantity() };
+    }
+
+private:
+    static constexpr std::size_t MinimumSlots = 16;
+
+    // Slots are never reused, so once they run out we either double them, if at least half are still live, or renumber the live orders from
+    // zero in time priority order. Either way memory stays proportional to the level and the cost is amortised O(1) per order.
+    // Growing touches only the trees, renumbering walks the level and reads every order, which is what a deep and growing level would
+    // otherwise pay on every doubling.
+    void Compact()
+    {
+        if (nextSlot_ > 0 && 2 * entries_.size() >= nextSlot_)
+        {
+            counts_.Grow(2 * nextSlot_);
+            quantities_.Grow(2 * nextSlot_);
+            return;
+        }
+
+        const std::size_t slots = std::max(MinimumSlots, 2 * (entries_.size() + 1));
+
+        std::vector<std::size_t> counts(slots);
+        std::vector<Quantity> quantities(slots);
+
+        std::size_t slot = 0;
+        for (auto& entry : entries_)
+        {
+            entry.slot_ = slot;
+            counts[slot] = 1;
+            quantities[slot] = entry.order_->GetRemainingQuantity();
+            ++slot;
+        }
+
+        counts_.Assign(counts);
+        quantities_.Assign(quantities);
+        nextSlot_ = slot;
+    }
+
+    Entries entries_;
+    FenwickTree<std::size_t> counts_;
+    FenwickTree<Quantity> quantities_;
+    std::size_t nextSlot_{ 0 };
+    Quantity quantity_{ 0 };
+};
@@ -0,0 +1,326 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <functional>
+
+#include "Orderbook.h"
+
+/*
+Benchmark of the matching loop: the side specialised Orderbook against the original runtime branching matcher.
+
+BaselineOrderbook is the original implementation (std::map per side, runtime Side and OrderType tests, per level data_ bookkeeping, add then match)
+with only the changes it needs to run at all:
+    - the fill quantity uses the ask's remaining quantity instead of its filled quantity (otherwise the loop never terminates),
+    - the front orders and level prices are copied before pop_front/erase instead of being read through dangling references,
+    - Fill And Kill cleanup cancels without re-taking the lock it already holds.
+It also drops two costs of the original that grow with the book rather than with the work done, so the comparison measures the side
+specialised matching rather than them:
+    - trades.reserve(orders_.size()) on every call,
+    - finding the new order's position with std::next(begin, size - 1), a walk of the whole level, instead of std::prev(end).
+*/
+class BaselineOrderbook
+{
+private:
+    struct OrderEntry
+    {
+        OrderPointer order_{ nullptr };
+        OrderPointers::iterator location_;
+    };
+
+    struct LevelData
+    {
+        Quantity quantity_{};
+        Quantity count_{};
+
+        enum class Action
+        {
+            Add,
+            Remove,
+            Match,
+        };
+    };
+
+    std::unordered_map<Price, LevelData> data_;
+    std::unordered_map<OrderId, OrderEntry> orders_;
+    std::map<Price, OrderPointers, std::greater<Price>> bids_;
+    std::map<Price, OrderPointers, std::less<Price>> asks_;
+    std::mutex ordersMutex_;
+
+    void CancelOrderInternal(OrderId orderId)
+    {
+        if (!orders_.contains(orderId))
+            return;
+
+        const auto [order, iterator] = orders_.at(orderId);
+        orders_.erase(orderId);
+
+        auto price = order->GetPrice();
+        if (order->GetSide() == Side::Buy)
+        {
+            auto& orders = bids_.at(price);
+            orders.erase(iterator);
+
+            if (orders.empty())
+                bids_.erase(price);
+        }
+        else
+        {
+            auto& orders = asks_.at(price);
+            orders.erase(iterator);
+
+            if (orders.empty())
+                asks_.erase(price);
+        }
+
+        UpdateLevelData(price, order->GetRemainingQuantity(), LevelData::Action::Remove);
+    }
+
+    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action)
+    {
+        auto& data = data_[price];
+
+        data.count_ += action == LevelData::Action::Add ? 1 : (action == LevelData::Action::Remove ? -1 : 0);
+        if (action == LevelData::Action::Remove || action == LevelData::Action::Match)
+            data.quantity_ -= quantity;
+        else
+            data.quantity_ += quantity;
+
+        if (data.count_ == 0)
+            data_.erase(price);
+    }
+
+    bool CanMatch(Side side, Price price) const
+    {
+        if (side == Side::Buy)
+        {
+            if (asks_.empty())
+                return false;
+
+            const auto& [bestAsk, _] = *asks_.begin();
+            return price >= bestAsk;
+        }
+        else
+        {
+            if (bids_.empty())
+                return false;
+
+            const auto& [bestBid, _] = *bids_.begin();
+            return price <= bestBid;
+        }
+    }
+
+    Trades MatchOrders()
+    {
+        Trades trades;
+
+        while (true)
+        {
+            if (bids_.empty() || asks_.empty())
+                break;
+
+            auto& [bidPrice, bids] = *bids_.begin();
+            auto& [askPrice, asks] = *asks_.begin();
+
+            if (bidPrice < askPrice)
+                break;
+
+            while (bids.size() && asks.size())
+            {
+                const auto bid = bids.front();
+                const auto ask = asks.front();
+
+                Quantity quantity = std::min(bid->GetRemainingQuantity(), ask->GetRemainingQuantity());
+                bid->Fill(quantity);
+                ask->Fill(quantity);
+
+                if (bid->IsFilled())
+                {
+                    bids.pop_front();
+                    orders_.erase(bid->GetOrderId());
+                }
+
+                if (ask->IsFilled())
+                {
+                    asks.pop_front();
+                    orders_.erase(ask->GetOrderId());
+                }
+
+                trades.push_back(Trade{
+                    TradeInfo { bid->GetOrderId(), bid->GetPrice(), quantity },
+                    TradeInfo { ask->GetOrderId(), ask->GetPrice(), quantity }
+                });
+
+                UpdateLevelData(bid->GetPrice(), quantity, bid->IsFilled() ? LevelData::Action::Remove : LevelData::Action::Match);
+                UpdateLevelData(ask->GetPrice(), quantity, ask->IsFilled() ? LevelData::Action::Remove : LevelData::Action::Match);
+            }
+
+            const Price bidLevel = bidPrice;
+            const Price askLevel = askPrice;
+
+            if (bids.empty())
+            {
+                bids_.erase(bidLevel);
+                data_.erase(bidLevel);
+            }
+
+            if (asks.empty())
+            {
+                asks_.erase(askLevel);
+                data_.erase(askLevel);
+            }
+        }
+
+        if (!bids_.empty())
+        {
+            auto& [_, bids] = *bids_.begin();
+            auto& order = bids.front();
+            if (order->GetOrderType() == OrderType::FillAndKill)
+                CancelOrderInternal(order->GetOrderId());
+        }
+
+        if (!asks_.empty())
+        {
+            auto& [_, asks] = *asks_.begin();
+            auto& order = asks.front();
+            if (order->GetOrderType() == OrderType::FillAndKill)
+                CancelOrderInternal(order->GetOrderId());
+        }
+
+        return trades;
+    }
+
+public:
+    Trades AddOrder(OrderPointer order)
+    {
+        std::scoped_lock ordersLock{ ordersMutex_ };
+
+        if (orders_.contains(order->GetOrderId()))
+            return { };
+
+        if (order->GetOrderType() == OrderType::FillAndKill && !CanMatch(order->GetSide(), order->GetPrice()))
+            return { };
+
+        OrderPointers::iterator iterator;
+
+        if (order->GetSide() == Side::Buy)
+        {
+            auto& orders = bids_[order->GetPrice()];
+            orders.push_back(order);
+            iterator = std::prev(orders.end());
+        }
+        else
+        {
+            auto& orders = asks_[order->GetPrice()];
+            orders.push_back(order);
+            iterator = std::prev(orders.end());
+        }
+
+        orders_.insert({ order->GetOrderId(), OrderEntry{ order, iterator } });
+
+        UpdateLevelData(order->GetPrice(), order->GetRemainingQuantity(), LevelData::Action::Add);
+
+        return MatchOrders();
+    }
+
+    std::size_t Size() const { return orders_.size(); }
+};
+
+// Orders are built before timing so only AddOrder, and the matching it triggers, is measured.
+struct Workload
+{
+    std::vector<OrderPointer> resting_;
+    std::vector<OrderPointer> aggressors_;
+};
+
+using WorkloadFactory = std::function<Workload()>;
+
+// Levels x depth resting asks, then one Good Til Cancel buy per level for exactly the level's quantity, so every aggressor sweeps one full level.
+Workload MakeSweepWorkload(int levels, int depth)
+{
+    Workload workload;
+    OrderId orderId = 1;
+
+    for (int level = 0; level < levels; ++level)
+        for (int i = 0; i < depth; ++i)
+            workload.resting_.push_back(std::make_shared<Order>(OrderType::GoodTilCancel, orderId++, Side::Sell, 1000 + level, 10));
+
+    for (int level = 0; level < levels; ++level)
+        workload.aggressors_.push_back(std::make_shared<Order>(OrderType::GoodTilCancel, orderId++, Side::Buy, 1000 + level, 10 * depth));
+
+    return workload;
+}
+
+// Random Good Til Cancel flow around a fixed mid, roughly one order in ten crosses.
+Workload MakeRandomWorkload(int count)
+{
+    Workload workload;
+    std::mt19937 random{ 42 };
+
+    for (int i = 0; i < count; ++i)
+    {
+        const Side side = random() & 1 ? Side::Buy : Side::Sell;
+        const int sign = side == Side::Buy ? 1 : -1;
+        const Price price = 1000 - sign * static_cast<int>(random() % 50) + sign * (static_cast<int>(random() % 60) - 30) / 3;
+        workload.aggressors_.push_back(std::make_shared<Order>(OrderType::GoodTilCancel, i + 1, side, price, 1 + random() % 100));
+    }
+
+    return workload;
+}
+
+// One run on a fresh book and fresh orders. Returns nanoseconds per trade produced.
+template <typename Book>
+double MeasureOnce(const WorkloadFactory& makeWorkload)
+{
+    Workload workload = makeWorkload();
+    Book book;
+    for (auto& order : workload.resting_)
+        book.AddOrder(order);
+
+    std::size_t trades = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto& order : workload.aggressors_)
+        trades += book.AddOrder(order).size();
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    return elapsed / static_cast<double>(std::max<std::size_t>(trades, 1));
+}
+
+int main()
+{
+    constexpr int Runs = 8;
+
+    const std::pair<const char*, WorkloadFactory> workloads[] = {
+        { "sweep 1000 levels x 100 orders", [] { return MakeSweepWorkload(1000, 100); } },
+        { "sweep 10000 levels x 4 orders", [] { return MakeSweepWorkload(10000, 4); } },
+        { "random 50000 orders", [] { return MakeRandomWorkload(50000); } },
+    };
+
+    std::cout << std::left << std::setw(34) << "workload" << std::right
+        << std::setw(20) << "baseline ns/trade" << std::setw(20) << "current ns/trade" << std::setw(10) << "speedup" << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& [name, makeWorkload] : workloads)
+    {
+        // Whichever book runs second inherits the heap left by the first, so alternate the order and keep the best run of each.
+        double baseline = std::numeric_limits<double>::max();
+        double current = std::numeric_limits<double>::max();
+        for (int run = 0; run < Runs; ++run)
+        {
+            if (run % 2 == 0)
+            {
+                baseline = std::min(baseline, MeasureOnce<BaselineOrderbook>(makeWorkload));
+                current = std::min(current, MeasureOnce<Orderbook>(makeWorkload));
+            }
+            else
+            {
+                current = std::min(current, MeasureOnce<Orderbook>(makeWorkload));
+                baseline = std::min(baseline, MeasureOnce<BaselineOrderbook>(makeWorkload));
+            }
+        }
+
+        std::cout << std::left << std::setw(34) << name << std::right
+            << std::setw(20) << baseline << std::setw(20) << current << std::setw(9) << baseline / current << "x\n";
+    }
+
+    return 0;
+}
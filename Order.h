@@ -52,6 +52,9 @@ public:
 
         if (!std::isfinite(price))
             throw std::logic_error(std::format("Order ({}) must have a tradable price.\n", GetOrderId()));
+
+        price_ = price;
+        orderType_ = OrderType::GoodTilCancel;
      }
 
 private:
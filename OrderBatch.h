@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "Usings.h"
+#include "Side.h"
+
+// Structure of arrays batch of candidate orders, laid out so validation can load the same field of several orders at once.
+class OrderBatch
+{
+public:
+    void Add(OrderId orderId, Side side, Price price, Quantity quantity)
+    {
+        orderIds_.push_back(orderId);
+        sides_.push_back(side);
+        prices_.push_back(price);
+        quantities_.push_back(quantity);
+    }
+
+    void Reserve(std::size_t size)
+    {
+        orderIds_.reserve(size);
+        sides_.reserve(size);
+        prices_.reserve(size);
+        quantities_.reserve(size);
+    }
+
+    void Clear()
+    {
+        orderIds_.clear();
+        sides_.clear();
+        prices_.clear();
+        quantities_.clear();
+    }
+
+    std::size_t Size() const { return orderIds_.size(); }
+    const OrderIds& GetOrderIds() const { return orderIds_; }
+    const std::vector<Side>& GetSides() const { return sides_; }
+    const std::vector<Price>& GetPrices() const { return prices_; }
+    const std::vector<Quantity>& GetQuantities() const { return quantities_; }
+
+private:
+    OrderIds orderIds_;
+    std::vector<Side> sides_;
+    std::vector<Price> prices_;
+    std::vector<Quantity> quantities_;
+};
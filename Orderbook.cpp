@@ -1,4 +1,3 @@
-#include <iostream>
 #include <chrono>
 #include <ctime> 
 
@@ -78,212 +77,136 @@ void Orderbook::CancelOrders(OrderIds orderIds)
 
 void Orderbook::CancelOrderInternal(OrderId orderId)
 {
-    if (!orders_.contains(orderId))
+    auto entry = orders_.find(orderId);
+    if (entry == orders_.end())
         return;
 
-    const auto& [order, iterator] = orders_.at(orderId);
-    orders_.erase(orderId);
+    const auto [order, iterator] = entry->second;
+    orders_.erase(entry);
 
     if (order->GetSide() == Side::Buy)
-    {
-        auto price = order->GetPrice();
-        auto& orders = bids_.at(price);
-        orders.erase(iterator);
-
-        if (orders.empty())
-            bids_.erase(price);
-    }
+        bids_.Remove(order->GetPrice(), iterator);
     else
-    {
-        auto price = order->GetPrice();
-        auto& orders = asks_.at(price);
-        orders.erase(iterator);
-
-        if (orders.empty())
-            asks_.erase(price);
-    }
-
-    OnOrderCancelled(order);
+        asks_.Remove(order->GetPrice(), iterator);
 }
 
-void Orderbook::OnOrderCancelled(OrderPointer order)
+template <Side S>
+BookSide<S>& Orderbook::GetBookSide()
 {
-    UpdateLevelData(order->GetPrice(), order->GetRemainingQuantity(), LevelData::Action::Remove);
-}
-
-void Orderbook::OnOrderAdded(OrderPointer order)
-{
-    UpdateLevelData(order->GetPrice(), order->GetRemainingQuantity(), LevelData::Action::Add);
+    if constexpr (S == Side::Buy)
+        return bids_;
+    else
+        return asks_;
 }
 
-void Orderbook::OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled)
+template <Side S>
+const BookSide<S>& Orderbook::GetBookSide() const
 {
-    UpdateLevelData(price, quantity, isFullyFilled ? LevelData::Action::Remove : LevelData::Action::Match);
+    if constexpr (S == Side::Buy)
+        return bids_;
+    else
+        return asks_;
 }
 
-void Orderbook::UpdateLevelData(Price price, Quantity quantity, LevelData::Action action)
+template <Side S>
+bool Orderbook::CanFullyFill(Price price, Quantity quantity) const
 {
-     auto & data = data_[price];
-
-     data.count_ += action == LevelData::Action::Add ? 1 : (action == LevelData::Action::Remove ? -1 : 0);
-     if (action == LevelData::Action::Remove || action == LevelData::Action::Match)
-        data.quantity_ -= quantity;
-    else
-        data.quantity_ += quantity;
-    
-    if (data.count_ == 0)
-        data_.erase(price);
-
+    // Walk the opposite side from its best price up to our limit, summing the quantity resting at each level.
+    return GetBookSide<OppositeSide<S>>().HasDepth(price, quantity);
 }
 
-bool Orderbook::CanFullyFill(Side side, Price price, Quantity quantity) const
+template <Side S>
+bool Orderbook::CanMatch(Price price) const
 {
-    if (!CanMatch(side, price))
+    const auto& contra = GetBookSide<OppositeSide<S>>();
+    if (contra.Empty())
         return false;
-    
-    std::optional<Price> threshold;
-    if (side == Side::Buy)
-    {
-        const auto& [askPrice, _] = *asks_.begin();
-        threshold = askPrice;
-    }
-    else
-    {
-        const auto& [bidPrice, _] = *bids_.begin();
-        threshold = bidPrice;
-    }
 
-    for (const auto& [levelPrice, levelData] : data_)
-    {
-        if (threshold.has_value() && 
-            ((side == Side::Buy && threshold.value() > levelPrice) || 
-             (side == Side::Sell && threshold.value() < levelPrice)))
-            continue;
-        
-        if ((side == Side::Buy && levelPrice > price) || 
-            (side == Side::Sell && levelPrice < price))
-            continue;
-        
-        if (quantity <= levelData.quantity_)
-            return true;
-        
-        quantity -= levelData.quantity_;
-    }
-
-    return false;
+    // Buy: our bid is at least the best ask. Sell: our ask is at most the best bid.
+    return BookSide<S>::Crosses(price, contra.BestPrice());
 }
 
-
-bool Orderbook::CanMatch(Side side, Price price) const
-{
-    // Buy side check
-    if (side == Side::Buy)
-    {
-        if (asks_.empty())
-            return false;
-        
-        // Get best ask from our ordered map.
-        const auto& [bestAsk, _] = *asks_.begin();
-        // If our bid price is higher than the best ask then we can fill.
-        return price >= bestAsk;
-    }
-    // Sell side check
-    else
-    {
-        if (bids_.empty())
-            return false;
-        
-        // Get best bid from our ordered map.
-        const auto& [bestBid, _] = *bids_.begin();
-        // if our is at least as big as our ask then we fill the order.
-        return price <= bestBid;
-    }
-}
-
-Trades Orderbook::MatchOrders()
+// The book is never crossed between calls, so only the incoming order can trade. We match it against the opposite side before it rests,
+// which leaves the inner loop with no side or order type checks.
+template <Side S>
+Trades Orderbook::MatchOrders(const OrderPointer& order)
 {
     Trades trades;
-    // Assuming all orders can fill the orderbook we can create a maximum size for the vector 
-    trades.reserve(orders_.size());
+    auto& contra = GetBookSide<OppositeSide<S>>();
+    auto& levels = contra.GetLevels();
 
-    while (true)
+    while (!order->IsFilled() && !contra.Empty() && BookSide<S>::Crosses(order->GetPrice(), contra.BestPrice()))
     {
-        if (bids_.empty() || asks_.empty())
-            break;
+        auto level = levels.begin();
+        auto& orders = level->second;
 
-        auto& [bidPrice, bids] = *bids_.begin();
-        auto& [askPrice, asks] = *asks_.begin();
+        // Most incoming orders only reach the best level, so size the trades for it once they are known to cross.
+        if (trades.empty())
+            trades.reserve(orders.Size());
 
-        // If our highest bidPrice is not as big as our lowest ask price no orders can be filled. Break.
-        if (bidPrice < askPrice)
-            break;
-
-        while(bids.size() && asks.size())
+        while (!order->IsFilled() && !orders.Empty())
         {
-            auto& bid = bids.front();
-            auto& ask = asks.front();
-            
-            Quantity quantity = std::min(bid->GetRemainingQuantity(), ask->GetFilledQuantity());
-            bid->Fill(quantity);
-            ask->Fill(quantity);
-            
-            if (bid->IsFilled())
-            {
-                bids.pop_front();
-                orders_.erase(bid->GetOrderId());
-            }
+            // The level keeps the resting order alive until PopFront, so no need to copy the pointer.
+            const Order& resting = *orders.Front();
+
+            Quantity quantity = std::min(order->GetRemainingQuantity(), resting.GetRemainingQuantity());
+            order->Fill(quantity);
+            orders.FillFront(quantity);
 
-            if (ask->IsFilled())
+            const TradeInfo incomingTrade{ order->GetOrderId(), order->GetPrice(), quantity };
+            const TradeInfo restingTrade{ resting.GetOrderId(), resting.GetPrice(), quantity };
+            if constexpr (S == Side::Buy)
+                trades.push_back(Trade{ incomingTrade, restingTrade });
+            else
+                trades.push_back(Trade{ restingTrade, incomingTrade });
+
+            if (resting.IsFilled())
             {
-                asks.pop_front();
-                orders_.erase(ask->GetOrderId());
+                orders_.erase(resting.GetOrderId());
+                orders.PopFront();
             }
+        }
 
-            if (bids.empty())
-                bids_.erase(bidPrice);
-
-            if (asks.empty())
-                asks_.erase(askPrice);
+        if (orders.Empty())
+            levels.erase(level);
+    }
 
-            trades.push_back(Trade{ 
-                TradeInfo { bid->GetOrderId(), bid->GetPrice(), quantity},
-                TradeInfo { ask->GetOrderId(), ask->GetPrice(), quantity}
-            });
+    if (analytics_ && !trades.empty())
+        analytics_->OnTrades<S>(trades);
 
-            OnOrderMatched(bid->GetPrice(), quantity, bid->IsFilled());
-            OnOrderMatched(ask->GetPrice(), quantity, ask->IsFilled());
+    return trades;
+}
 
-        }
-        
-        if (bids.empty())
-        {
-            bids_.erase(bidPrice);
-            data_.erase(bidPrice);
-        }
-    
-        if (asks.empty())
-        {
-            asks_.erase(askPrice);
-            data_.erase(askPrice);
-        }
-	}
+template <Side S>
+Trades Orderbook::AddOrderInternal(const OrderPointer& order)
+{
+    const auto& contra = GetBookSide<OppositeSide<S>>();
 
-    if (!bids_.empty())
+    if (order->GetOrderType() == OrderType::Market)
     {
-        auto& [_, bids] = *bids_.begin();
-        auto& order = bids.front();
-        if (order->GetOrderType() == OrderType::FillAndKill)
-            CancelOrder(order->GetOrderId());
-    }
+        // We will essentially create a limit order for the market order, with the worst price as the upper or lower bound (depending on the side).
+        // This way the market order will buy/sell from the best available orders until it is either filled or there are no more orders to match against.
+        if (contra.Empty())
+            return { }; // No orders to match against.
 
-    if (!asks_.empty())
-    {
-        auto& [_, asks] = *asks_.begin();
-        auto& order = asks.front();
-        if (order->GetOrderType() == OrderType::FillAndKill)
-            CancelOrder(order->GetOrderId());
+        order->ToGoodTillCancel(contra.WorstPrice());
     }
 
+    if (order->GetOrderType() == OrderType::FillAndKill && !CanMatch<S>(order->GetPrice()))
+        return { };
+
+    if (order->GetOrderType() == OrderType::FillOrKill && !CanFullyFill<S>(order->GetPrice(), order->GetRemainingQuantity()))
+        return { };
+
+    Trades trades = MatchOrders<S>(order);
+
+    // Fill And Kill orders never rest, whatever is left unfilled is cancelled.
+    if (order->IsFilled() || order->GetOrderType() == OrderType::FillAndKill)
+        return trades;
+
+    auto iterator = GetBookSide<S>().Add(order);
+    orders_.insert({ order->GetOrderId(), OrderEntry{ order, iterator } });
+
     return trades;
 }
 
@@ -291,9 +214,18 @@ Trades Orderbook::MatchOrders()
 // PUBLIC METHODS
 Orderbook::Orderbook() : ordersPruneThread_{ [this] { PruneGoodForDayOrders(); } } { }
 
+Orderbook::Orderbook(BarSpecification barSpecification)
+    : analytics_{ std::make_unique<TradeAnalytics>(barSpecification) },
+    ordersPruneThread_{ [this] { PruneGoodForDayOrders(); } }
+{ }
+
 Orderbook::~Orderbook()
 {
-    shutdown_.store(true, std::memory_order_release);
+    {
+        // Set the flag under the lock so the prune thread cannot miss the notification between its check and its wait.
+        std::scoped_lock ordersLock{ ordersMutex_ };
+        shutdown_.store(true, std::memory_order_release);
+    }
     shutdownConditionVariable_.notify_one();
     ordersPruneThread_.join();
 }
@@ -306,50 +238,11 @@ Trades Orderbook::AddOrder(OrderPointer order)
     if (orders_.contains(order->GetOrderId()))
         return { };
 
-    if (order->GetOrderType() == OrderType::Market)
-    {
-        // We will essentially create a limit order for the market order, with the worst price as the upper or lower bound (depending on the side).
-        // This way the market order will buy/sell from the best available orders until it is either filled or there are no more orders to match against.
-        if (order->GetSide() == Side::Buy && !asks_.empty())
-        {
-            const auto& [worstAsk, _] = *asks_.rbegin();
-            order->ToGoodTillCancel(worstAsk);
-        }
-        else if (order->GetSide() == Side::Sell && !bids_.empty())
-        {
-            const auto& [worstBid, _] = *bids_.rbegin();
-            order->ToGoodTillCancel(worstBid);
-        }
-        else
-            return { }; // No orders to match against.
-    }
-
-    if (order->GetOrderType() == OrderType::FillAndKill && !CanMatch(order->GetSide(), order->GetPrice()))
-        return { };
-
-    if (order->GetOrderType() == OrderType::FillOrKill && !CanFullyFill(order->GetSide(), order->GetPrice(), order->GetRemainingQuantity()))
-        return { };
-
-    OrderPointers::iterator iterator;
-
+    // Dispatch on side once, everything past this point is specialised for the order's side.
     if (order->GetSide() == Side::Buy)
-    {
-        auto& orders = bids_[order->GetPrice()];
-        orders.push_back(order);
-        iterator = std::next(orders.begin(), orders.size() - 1);
-    }
-    else
-    {
-        auto& orders = asks_[order->GetPrice()];
-        orders.push_back(order);
-        iterator = std::next(orders.begin(), orders.size() - 1);
-    }
-
-    orders_.insert({ order->GetOrderId(), OrderEntry{ order, iterator } });
-
-    OnOrderAdded(order);
+        return AddOrderInternal<Side::Buy>(order);
 
-    return MatchOrders();
+    return AddOrderInternal<Side::Sell>(order);
 }
 
 void Orderbook::CancelOrder(OrderId orderId)
@@ -395,33 +288,76 @@ OrderbookLevelInfos Orderbook::GetOrderInfos() const
     bidInfos.reserve(orders_.size());
     askInfos.reserve(orders_.size());
 
-    auto CreateLevelInfos = [](Price price, const OrderPointers& orders)
+    // Each level keeps its own running quantity, so no need to walk its orders.
+    auto CreateLevelInfos = [](Price price, const LevelQueue& orders)
     {
-        // Recursively get number of orders
-        return LevelInfo{ price, std::accumulate(orders.begin(), orders.end(), (Quantity)0,
-            [](std::size_t runningSum, const OrderPointer& order)
-            { return runningSum + order->GetRemainingQuantity(); }) };
+        return LevelInfo{ price, orders.GetQuantity() };
     };
 
-    for (const auto& [price, orders] :bids_)
+    for (const auto& [price, orders] : bids_.GetLevels())
         bidInfos.push_back(CreateLevelInfos(price, orders));
 
-    for (const auto& [price, orders] : asks_)
+    for (const auto& [price, orders] : asks_.GetLevels())
         askInfos.push_back(CreateLevelInfos(price, orders));
 
     return OrderbookLevelInfos{ bidInfos, askInfos };
 }
 
-int main()
+std::optional<QueuePosition> Orderbook::GetQueuePosition(OrderId orderId) const
 {
-    Orderbook orderbook;
-    const OrderId orderId = 1;
-    orderbook.AddOrder(std::make_shared<Order>(OrderType::GoodTilCancel, orderId, Side::Buy, 100, 10));
-    std::cout << orderbook.Size() << std::endl; // 1
+    std::scoped_lock ordersLock{ ordersMutex_ };
+
+    auto entry = orders_.find(orderId);
+    if (entry == orders_.end())
+        return std::nullopt;
+
+    const auto& [order, iterator] = entry->second;
+    if (order->GetSide() == Side::Buy)
+        return bids_.GetQueuePosition(order->GetPrice(), iterator);
 
-    orderbook.CancelOrder(orderId);
-    std::cout << orderbook.Size() << std::endl; // 0
+    return asks_.GetQueuePosition(order->GetPrice(), iterator);
+}
+
+std::optional<TradeAnalyticsSnapshot> Orderbook::GetTradeAnalytics() const
+{
+    if (!analytics_)
+        return std::nullopt;
+
+    return analytics_->GetSnapshot();
+}
+
+std::optional<TradeAnalyticsSummary> Orderbook::GetTradeSummary() const
+{
+    if (!analytics_)
+        return std::nullopt;
+
+    return analytics_->GetSummary();
+}
+
+// Screen a batch of candidate orders against the current best bid and offer before any of them are added.
+// The price, quantity and notional checks run in the validator's vector kernels and the in batch duplicate check in its shared hash pass,
+// only the lookup of ids already in the book is done here.
+AcceptMask Orderbook::ValidateOrders(const OrderBatch& batch, const BatchValidator& validator) const
+{
+    // Only the best bid and offer are needed from the book, so the kernels run without holding up matching.
+    std::optional<Price> bestBid;
+    std::optional<Price> bestAsk;
+    {
+        std::scoped_lock ordersLock{ ordersMutex_ };
+        if (!bids_.Empty())
+            bestBid = bids_.BestPrice();
+        if (!asks_.Empty())
+            bestAsk = asks_.BestPrice();
+    }
+
+    AcceptMask accept = validator.Validate(batch, bestBid, bestAsk);
+
+    std::scoped_lock ordersLock{ ordersMutex_ };
 
-    return 0;
+    const auto& orderIds = batch.GetOrderIds();
+    for (std::size_t i = 0; i < batch.Size(); ++i)
+        if (accept[i] && orders_.contains(orderIds[i]))
+            accept[i] = 0;
 
+    return accept;
 }
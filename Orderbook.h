@@ -7,12 +7,18 @@
 #include <thread>
 #include <condition_variable>
 #include <mutex>
+#include <optional>
+#include <memory>
 
 #include "Usings.h"
 #include "Order.h"
 #include "OrderModify.h"
 #include "OrderbookLevelInfos.h"
 #include "Trade.h"
+#include "QueuePosition.h"
+#include "TradeAnalytics.h"
+#include "BatchValidator.h"
+#include "BookSide.h"
 
 // Main Orderbook class
 class Orderbook
@@ -26,55 +32,45 @@ private:
     struct OrderEntry
     {
         OrderPointer order_{ nullptr };
-        OrderPointers::iterator location_;
+        LevelQueue::iterator location_;
     };
 
-    struct LevelData
-    {
-        Quantity quantity_{};
-        Quantity count_{};
-    
-        enum class Action
-        {
-            Add,
-            Remove,
-            Match,
-        };
-    };
-
-    std::unordered_map<Price, LevelData> data_;
-    
     // All orders
     std::unordered_map<OrderId, OrderEntry> orders_;
 
     // Order bids in descending order (largest first)
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
+    BookSide<Side::Buy> bids_;
 
     // Order asks in ascending order (smallest first)
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
+    BookSide<Side::Sell> asks_;
+
+    // Optional trade analytics, chosen at construction and never changed so it can be read without the orders lock.
+    const std::unique_ptr<TradeAnalytics> analytics_;
 
     // Add mutex and threads for handling Good For Day orders
     mutable std::mutex ordersMutex_;
-    std::thread ordersPruneThread_;
     std::condition_variable shutdownConditionVariable_;
     std::atomic<bool> shutdown_{ false };
+    // Declared last so the mutex, condition variable and flag are constructed before the thread starts using them.
+    std::thread ordersPruneThread_;
     
     void PruneGoodForDayOrders();
 
     void CancelOrders(OrderIds orderIds);
     void CancelOrderInternal(OrderId orderId);
 
-    void OnOrderCancelled(OrderPointer order);
-    void OnOrderAdded(OrderPointer order);
-    void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
-    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
+    // Side specialised core. Side is only tested once in the public entry points, everything below is resolved at compile time.
+    template <Side S> BookSide<S>& GetBookSide();
+    template <Side S> const BookSide<S>& GetBookSide() const;
 
-    bool CanFullyFill(Side side, Price price, Quantity quantity) const;
-    bool CanMatch(Side side, Price price) const;
-    Trades MatchOrders();
+    template <Side S> Trades AddOrderInternal(const OrderPointer& order);
+    template <Side S> bool CanFullyFill(Price price, Quantity quantity) const;
+    template <Side S> bool CanMatch(Price price) const;
+    template <Side S> Trades MatchOrders(const OrderPointer& order);
 
 public:
     Orderbook();
+    explicit Orderbook(BarSpecification barSpecification);
     // Create unique ownership of the orderbook so that it cannot be copied or moved.
     void operator=(const Orderbook&) = delete;
     Orderbook(Orderbook&&) = delete;
@@ -87,5 +83,11 @@ public:
     Trades MatchOrder(OrderModify order);
     std::size_t Size() const;
     OrderbookLevelInfos GetOrderInfos() const;
+    std::optional<QueuePosition> GetQueuePosition(OrderId orderId) const;
+    // Both analytics reads are lock free and never hold up matching. The snapshot includes the per price table and copies about 7 KB,
+    // the summary is the session and bar statistics only, cheap enough to poll from other threads while the book is matching.
+    std::optional<TradeAnalyticsSnapshot> GetTradeAnalytics() const;
+    std::optional<TradeAnalyticsSummary> GetTradeSummary() const;
+    AcceptMask ValidateOrders(const OrderBatch& batch, const BatchValidator& validator) const;
 
 };
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Usings.h"
+
+// Where a resting order stands in the time priority queue of its price level.
+struct QueuePosition
+{
+    std::size_t ordersAhead_;
+    Quantity quantityAhead_;
+};
@@ -0,0 +1,170 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "LevelQueue.h"
+
+/*
+Randomized test of the queue position bookkeeping in LevelQueue.
+
+A LevelQueue is driven through random pushes, partial fills of the front order, front orders filled and popped, front cancels and
+cancels from the middle of the level. After every operation GetQuantity, and the queue position of a few random orders, are compared
+with a plain walk of a shadow copy of the level. The whole level is compared every so often.
+
+The level grows to a few thousand orders, then churns at a few hundred and at a handful, so Compact() runs many times both growing
+the trees and renumbering the live orders.
+*/
+
+namespace
+{
+    struct Phase
+    {
+        const char* name_;
+        int operations_;
+        std::size_t targetSize_;
+    };
+
+    class Checker
+    {
+    public:
+        explicit Checker(std::mt19937_64& random)
+            : random_{ random }
+        { }
+
+        void Run(const Phase& phase)
+        {
+            for (int operation = 0; operation < phase.operations_; ++operation)
+            {
+                Step(phase.targetSize_);
+
+                CheckQuantity(phase.name_);
+                for (int sample = 0; sample < 4 && !shadow_.empty(); ++sample)
+                    CheckPosition(phase.name_, random_() % shadow_.size());
+
+                if (operation % 512 == 0)
+                    for (std::size_t index = 0; index < shadow_.size(); ++index)
+                        CheckPosition(phase.name_, index);
+            }
+        }
+
+        std::size_t GetChecks() const { return checks_; }
+        std::size_t GetFailures() const { return failures_; }
+
+    private:
+        // Pushes are more likely below the target size and removals above it, so the level hovers around the target.
+        void Step(std::size_t targetSize)
+        {
+            const bool grow = shadow_.empty() || random_() % 100 < (shadow_.size() < targetSize ? 70u : 30u);
+            if (grow)
+            {
+                const Quantity quantity = static_cast<Quantity>(1 + random_() % 1000);
+                auto order = std::make_shared<Order>(OrderType::GoodTilCancel, nextOrderId_++, Side::Buy, 100, quantity);
+                shadow_.push_back(level_.Push(order));
+                return;
+            }
+
+            switch (random_() % 4)
+            {
+            case 0:
+            {
+                // Partial fill of the front order, as the matching loop does when the incoming order runs out first.
+                const Quantity remaining = level_.Front()->GetRemainingQuantity();
+                if (remaining > 1)
+                    level_.FillFront(static_cast<Quantity>(1 + random_() % (remaining - 1)));
+                break;
+            }
+            case 1:
+                // Front order filled completely, then popped.
+                level_.FillFront(level_.Front()->GetRemainingQuantity());
+                level_.PopFront();
+                shadow_.erase(shadow_.begin());
+                break;
+            case 2:
+                // Front order cancelled.
+                level_.Erase(shadow_.front());
+                shadow_.erase(shadow_.begin());
+                break;
+            default:
+            {
+                // Cancel from anywhere in the level, usually not the front.
+                const std::size_t index = random_() % shadow_.size();
+                level_.Erase(shadow_[index]);
+                shadow_.erase(shadow_.begin() + static_cast<std::ptrdiff_t>(index));
+                break;
+            }
+            }
+        }
+
+        void CheckQuantity(const char* phase)
+        {
+            Quantity expected = 0;
+            for (const auto& location : shadow_)
+                expected += location->order_->GetRemainingQuantity();
+
+            ++checks_;
+            if (level_.GetQuantity() != expected || level_.Size() != shadow_.size())
+                Fail(phase) << "level quantity " << level_.GetQuantity() << " size " << level_.Size()
+                    << ", expected " << expected << " size " << shadow_.size() << '\n';
+        }
+
+        void CheckPosition(const char* phase, std::size_t index)
+        {
+            Quantity quantityAhead = 0;
+            for (std::size_t i = 0; i < index; ++i)
+                quantityAhead += shadow_[i]->order_->GetRemainingQuantity();
+
+            const QueuePosition position = level_.GetQueuePosition(shadow_[index]);
+
+            ++checks_;
+            if (position.ordersAhead_ != index || position.quantityAhead_ != quantityAhead)
+                Fail(phase) << "order " << index << " of " << shadow_.size() << ": " << position.ordersAhead_ << " orders and "
+                    << position.quantityAhead_ << " ahead, expected " << index << " and " << quantityAhead << '\n';
+        }
+
+        std::ostream& Fail(const char* phase)
+        {
+            static std::ostream discard{ nullptr };
+            if (failures_++ >= 10)
+                return discard;
+
+            return std::cout << "MISMATCH " << phase << ", ";
+        }
+
+        std::mt19937_64& random_;
+        LevelQueue level_;
+        std::vector<LevelQueue::iterator> shadow_;
+        OrderId nextOrderId_{ 1 };
+        std::size_t checks_{ 0 };
+        std::size_t failures_{ 0 };
+    };
+}
+
+int main()
+{
+    const Phase phases[] = {
+        { "grow to 4000", 12000, 4000 },
+        { "churn at 300", 60000, 300 },
+        { "churn at 4", 40000, 4 },
+        { "grow to 2000", 6000, 2000 },
+        { "drain", 6000, 0 },
+    };
+
+    std::mt19937_64 random{ 20240612 };
+    std::size_t checks = 0;
+    std::size_t failures = 0;
+
+    // Several independent levels, so the result does not hinge on one random sequence.
+    for (int level = 0; level < 4; ++level)
+    {
+        Checker checker{ random };
+        for (const auto& phase : phases)
+            checker.Run(phase);
+
+        checks += checker.GetChecks();
+        failures += checker.GetFailures();
+    }
+
+    std::cout << checks << " checks, " << failures << " mismatches\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Usings.h"
+
+// Pre-trade limits applied to every incoming order.
+//  - priceCollar_: how far (in ticks) an order may be priced from the opposite best price (best ask for buys, best bid for sells).
+//  - maxQuantity_: largest quantity a single order may carry.
+//  - maxNotional_: largest price * quantity a single order may carry.
+struct RiskLimits
+{
+    Price priceCollar_;
+    Quantity maxQuantity_;
+    std::int64_t maxNotional_;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single writer, many reader publication of a trivially copyable value. The writer never waits: it bumps the sequence to odd,
+// stores the value, then bumps it back to even. Readers retry until they copy the value without the sequence changing underneath them.
+// The value is held as relaxed atomic words so a read that overlaps a write is a retry, never a data race.
+// A large value the writer keeps its own copy of can be republished in part: only the words it changed are stored, inside one
+// BeginWrite / EndWrite window, so the cost of a write follows what changed rather than the size of the value.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied word by word.");
+
+public:
+    SeqLock() { Store(T{ }); }
+
+    // The write functions must only be called by one thread at a time.
+    void Store(const T& value)
+    {
+        BeginWrite();
+        StoreRange(value, &value, sizeof(T));
+        EndWrite();
+    }
+
+    void BeginWrite()
+    {
+        const std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // Republish the size bytes at begin, which must lie inside value, the writer's copy of the whole value.
+    // Stores whole words, so the bytes either side of the range that share them are republished from value too.
+    void StoreRange(const T& value, const void* begin, std::size_t size)
+    {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+        const std::size_t offset = static_cast<std::size_t>(static_cast<const unsigned char*>(begin) - bytes);
+
+        for (std::size_t word = offset / WordSize; word < (offset + size + WordSize - 1) / WordSize; ++word)
+        {
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, bytes + word * WordSize, std::min(WordSize, sizeof(T) - word * WordSize));
+            words_[word].store(bits, std::memory_order_relaxed);
+        }
+    }
+
+    void EndWrite()
+    {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    T Load() const
+    {
+        std::array<std::uint64_t, Words> words;
+        while (true)
+        {
+            const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+
+            for (std::size_t i = 0; i < Words; ++i)
+                words[i] = words_[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr std::size_t WordSize = sizeof(std::uint64_t);
+    static constexpr std::size_t Words = (sizeof(T) + WordSize - 1) / WordSize;
+
+    std::atomic<std::uint64_t> sequence_{ 0 };
+    std::array<std::atomic<std::uint64_t>, Words> words_{ };
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <format>
+
+#include "Usings.h"
+#include "Side.h"
+#include "Trade.h"
+#include "TradeBar.h"
+#include "SeqLock.h"
+
+// How trades are grouped into bars: a new bar every interval of wall clock time, or every fixed amount of traded volume.
+struct BarSpecification
+{
+    enum class Type
+    {
+        Time,
+        Volume,
+    };
+
+    Type type_;
+    std::chrono::nanoseconds interval_{};
+    std::uint64_t volume_{};
+
+    static BarSpecification ByTime(std::chrono::nanoseconds interval) { return BarSpecification{ Type::Time, interval, 0 }; }
+    static BarSpecification ByVolume(std::uint64_t volume) { return BarSpecification{ Type::Volume, std::chrono::nanoseconds{ 0 }, volume }; }
+};
+
+// Traded volume at a single price.
+struct TradedLevel
+{
+    Price price_{};
+    std::uint64_t volume_{};
+    std::uint32_t tradeCount_{};
+};
+
+// Point in time copy of the analytics state. Fixed size, so taking one never allocates.
+struct TradeAnalyticsSnapshot
+{
+    static constexpr std::size_t BarCapacity = 64;
+    static constexpr std::size_t LevelCapacity = 256;
+
+    TradeBar session_;
+    TradeBar currentBar_;
+    // Most recent completed bars, oldest first. Only the first barCount_ are valid.
+    std::array<TradeBar, BarCapacity> bars_{};
+    std::size_t barCount_{};
+    // Unordered, entries with no trades are unused. Volume at prices that did not fit in the table goes to untrackedVolume_.
+    std::array<TradedLevel, LevelCapacity> levels_{};
+    std::uint64_t untrackedVolume_{};
+};
+
+// The small part of the analytics state, cheap enough to publish after every batch of trades.
+struct TradeAnalyticsSummary
+{
+    TradeBar session_;
+    TradeBar currentBar_;
+    // Most recently completed bar, empty until the first one closes.
+    TradeBar lastBar_;
+    // Bars completed since the book started, not capped by the snapshot's bar capacity.
+    std::uint64_t closedBarCount_{};
+};
+
+// Session, bar and per price statistics updated as trades are produced by the orderbook, in O(1) per fill and fixed memory.
+// OnTrades keeps its own copy of the state and republishes the words each batch of trades changed through a seqlock, and the session and
+// bars again through a second, small one. Readers on any thread copy from those without a lock and the matching thread never waits for them.
+class TradeAnalytics
+{
+public:
+    explicit TradeAnalytics(BarSpecification barSpecification)
+        : barSpecification_{ barSpecification }
+    {
+        if (barSpecification_.type_ == BarSpecification::Type::Time && barSpecification_.interval_.count() <= 0)
+            throw std::logic_error(std::format("Time bars must have a positive interval.\n"));
+
+        if (barSpecification_.type_ == BarSpecification::Type::Volume && barSpecification_.volume_ == 0)
+            throw std::logic_error(std::format("Volume bars must have a positive volume.\n"));
+    }
+
+    // Record the trades of one incoming order. Trades execute at the resting order's price, which is the ask for a buy and the bid for a sell.
+    // Must only be called by one thread at a time, the orderbook calls it under its own lock.
+    template <Side S>
+    void OnTrades(const Trades& trades)
+    {
+        const auto now = std::chrono::system_clock::now();
+
+        published_.BeginWrite();
+        for (const auto& trade : trades)
+        {
+            const TradeInfo& resting = S == Side::Buy ? trade.GetAskTrde() : trade.GetBidTarde();
+            OnFill(now, resting.price_, resting.quantity_);
+        }
+
+        Publish(state_.session_);
+        Publish(state_.currentBar_);
+        published_.EndWrite();
+
+        summary_.Store(TradeAnalyticsSummary{ state_.session_, state_.currentBar_, GetLastBar(state_), state_.closedBarCount_ });
+    }
+
+    // Session and bars only. Copies a few hundred bytes, so it is the one to poll.
+    TradeAnalyticsSummary GetSummary() const
+    {
+        TradeAnalyticsSummary summary = summary_.Load();
+
+        // As in GetSnapshot, a time bar whose interval has passed is reported as closed.
+        if (IsExpired(summary.currentBar_, std::chrono::system_clock::now()))
+        {
+            summary.lastBar_ = summary.currentBar_;
+            summary.currentBar_ = TradeBar{ };
+            ++summary.closedBarCount_;
+        }
+
+        return summary;
+    }
+
+    // Everything, including the per price table. Copies the whole state (about 7 KB), and is retried if a batch of trades is published
+    // while it copies, but never holds up the writer.
+    TradeAnalyticsSnapshot GetSnapshot() const
+    {
+        const State state = published_.Load();
+
+        TradeAnalyticsSnapshot snapshot;
+        snapshot.session_ = state.session_;
+        snapshot.currentBar_ = state.currentBar_;
+        snapshot.levels_ = state.levels_;
+        snapshot.untrackedVolume_ = state.untrackedVolume_;
+
+        // The completed bars are a ring buffer, unroll it oldest first.
+        snapshot.barCount_ = state.barCount_;
+        const std::size_t oldest = (state.nextBar_ + Capacity - state.barCount_) % Capacity;
+        for (std::size_t i = 0; i < state.barCount_; ++i)
+            snapshot.bars_[i] = state.bars_[(oldest + i) % Capacity];
+
+        // Time bars are only closed by the next fill, so after a quiet period the current bar may already be over. Report it as closed.
+        if (IsExpired(snapshot.currentBar_, std::chrono::system_clock::now()))
+        {
+            if (snapshot.barCount_ == Capacity)
+                std::shift_left(snapshot.bars_.begin(), snapshot.bars_.end(), 1);
+            else
+                ++snapshot.barCount_;
+
+            snapshot.bars_[snapshot.barCount_ - 1] = snapshot.currentBar_;
+            snapshot.currentBar_ = TradeBar{ };
+        }
+
+        return snapshot;
+    }
+
+private:
+    static constexpr std::size_t Capacity = TradeAnalyticsSnapshot::BarCapacity;
+    static constexpr std::size_t LevelCapacity = TradeAnalyticsSnapshot::LevelCapacity;
+    static constexpr std::size_t MaximumProbes = 16;
+
+    static_assert(std::has_single_bit(LevelCapacity), "The level table is indexed by the top bits of a 32 bit hash.");
+
+    // Everything OnTrades updates. The completed bars are a ring, nextBar_ is where the next one goes.
+    struct State
+    {
+        TradeBar session_;
+        TradeBar currentBar_;
+        std::array<TradeBar, Capacity> bars_{};
+        std::size_t barCount_{};
+        std::size_t nextBar_{};
+        std::uint64_t closedBarCount_{};
+        std::array<TradedLevel, LevelCapacity> levels_{};
+        std::uint64_t untrackedVolume_{};
+    };
+
+    static TradeBar GetLastBar(const State& state)
+    {
+        return state.barCount_ == 0 ? TradeBar{ } : state.bars_[(state.nextBar_ + Capacity - 1) % Capacity];
+    }
+
+    bool IsExpired(const TradeBar& bar, std::chrono::system_clock::time_point now) const
+    {
+        return barSpecification_.type_ == BarSpecification::Type::Time && !bar.Empty() &&
+            now >= bar.openTime_ + std::chrono::duration_cast<std::chrono::system_clock::duration>(barSpecification_.interval_);
+    }
+
+    // Republish one member of state_ that changed in the current batch.
+    template <typename Member>
+    void Publish(const Member& member)
+    {
+        published_.StoreRange(state_, &member, sizeof(Member));
+    }
+
+    void OnFill(std::chrono::system_clock::time_point time, Price price, Quantity quantity)
+    {
+        state_.session_.Add(time, price, quantity);
+        OnLevelTraded(price, quantity);
+
+        if (barSpecification_.type_ == BarSpecification::Type::Time)
+        {
+            // Bars are aligned to multiples of the interval, so each one opens at the start of its interval rather than at its first trade.
+            const auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+            const auto barStart = std::chrono::system_clock::time_point{
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceEpoch - sinceEpoch % barSpecification_.interval_) };
+
+            if (!state_.currentBar_.Empty() && state_.currentBar_.openTime_ != barStart)
+                CloseBar();
+
+            state_.currentBar_.Add(barStart, price, quantity);
+            return;
+        }
+
+        // Volume bars hold exactly barSpecification_.volume_, a fill larger than the space left is split across bars.
+        while (quantity > 0)
+        {
+            const std::uint64_t space = barSpecification_.volume_ - state_.currentBar_.volume_;
+            const Quantity taken = static_cast<Quantity>(std::min<std::uint64_t>(space, quantity));
+
+            state_.currentBar_.Add(time, price, taken);
+            quantity -= taken;
+
+            if (state_.currentBar_.volume_ == barSpecification_.volume_)
+                CloseBar();
+        }
+    }
+
+    void CloseBar()
+    {
+        auto& bar = state_.bars_[state_.nextBar_];
+        bar = state_.currentBar_;
+        state_.nextBar_ = (state_.nextBar_ + 1) % Capacity;
+        state_.barCount_ = std::min(state_.barCount_ + 1, Capacity);
+        ++state_.closedBarCount_;
+        state_.currentBar_ = TradeBar{ };
+
+        Publish(bar);
+        Publish(state_.barCount_);
+        Publish(state_.nextBar_);
+        Publish(state_.closedBarCount_);
+    }
+
+    // Open addressing table keyed by price. Entries are never removed, so an unused slot ends the probe.
+    // Probing is capped so a full table costs the same per fill as an empty one.
+    void OnLevelTraded(Price price, Quantity quantity)
+    {
+        // Knuth multiplicative hash. The top bits of the product depend on every bit of the price, the low bits only on its low bits.
+        std::size_t index = (static_cast<std::uint32_t>(price) * 2654435761u) >> (32 - std::countr_zero(LevelCapacity));
+        for (std::size_t probe = 0; probe < MaximumProbes; ++probe, index = (index + 1) % LevelCapacity)
+        {
+            auto& level = state_.levels_[index];
+            if (level.tradeCount_ == 0)
+                level.price_ = price;
+            else if (level.price_ != price)
+                continue;
+
+            level.volume_ += quantity;
+            ++level.tradeCount_;
+            Publish(level);
+            return;
+        }
+
+        state_.untrackedVolume_ += quantity;
+        Publish(state_.untrackedVolume_);
+    }
+
+    const BarSpecification barSpecification_;
+    // Only touched by OnTrades.
+    State state_;
+    // What readers see: the whole of state_, and its session and bars.
+    SeqLock<State> published_;
+    SeqLock<TradeAnalyticsSummary> summary_;
+};
@@ -0,0 +1,239 @@
+#include <iostream>
+#include <thread>
+#include <cmath>
+#include <stdexcept>
+
+#include "Orderbook.h"
+
+/*
+Deterministic test of the trade analytics reported by the orderbook.
+
+Each case drives an Orderbook with known orders and compares GetTradeAnalytics and GetTradeSummary with values worked out by hand:
+volume bars split across fills, OHLC and VWAP of bars and of the session, trade prices taken from the resting side, the completed bar
+ring unrolled oldest first, time bars aligned to their interval, and time bars reported as closed once their interval has passed.
+*/
+
+namespace
+{
+    std::size_t checks = 0;
+    std::size_t failures = 0;
+
+    void Expect(bool condition, const char* testCase, const char* what)
+    {
+        ++checks;
+        if (condition)
+            return;
+
+        ++failures;
+        std::cout << "FAILED " << testCase << ": " << what << '\n';
+    }
+
+    bool SameBar(const TradeBar& bar, Price open, Price high, Price low, Price close, std::uint64_t volume, std::int64_t notional, std::uint32_t tradeCount)
+    {
+        return bar.open_ == open && bar.high_ == high && bar.low_ == low && bar.close_ == close &&
+            bar.volume_ == volume && bar.notional_ == notional && bar.tradeCount_ == tradeCount;
+    }
+
+    void Rest(Orderbook& orderbook, OrderId orderId, Side side, Price price, Quantity quantity)
+    {
+        orderbook.AddOrder(std::make_shared<Order>(OrderType::GoodTilCancel, orderId, side, price, quantity));
+    }
+
+    std::uint64_t LevelVolume(const TradeAnalyticsSnapshot& snapshot, Price price)
+    {
+        for (const auto& level : snapshot.levels_)
+            if (level.tradeCount_ != 0 && level.price_ == price)
+                return level.volume_;
+
+        return 0;
+    }
+
+    // Volume bars of 25 filled by 10, 10 and 30: the last fill closes the first bar with 5 and fills the second bar with the other 25.
+    void TestVolumeBars()
+    {
+        const char* testCase = "volume bars";
+        Orderbook orderbook{ BarSpecification::ByVolume(25) };
+        Rest(orderbook, 1, Side::Sell, 100, 10);
+        Rest(orderbook, 2, Side::Sell, 101, 10);
+        Rest(orderbook, 3, Side::Sell, 102, 30);
+        Rest(orderbook, 4, Side::Buy, 102, 50);
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        Expect(snapshot.barCount_ == 2 && snapshot.currentBar_.Empty(), testCase, "two closed bars and no current bar");
+        Expect(SameBar(snapshot.bars_[0], 100, 102, 100, 102, 25, 100 * 10 + 101 * 10 + 102 * 5, 3), testCase, "first bar OHLC and volume");
+        Expect(SameBar(snapshot.bars_[1], 102, 102, 102, 102, 25, 102 * 25, 1), testCase, "second bar OHLC and volume");
+        Expect(std::abs(snapshot.bars_[0].GetVwap() - 100.8) < 1e-9, testCase, "first bar VWAP");
+        Expect(snapshot.bars_[1].GetVwap() == 102.0, testCase, "second bar VWAP");
+
+        Expect(SameBar(snapshot.session_, 100, 102, 100, 102, 50, 100 * 10 + 101 * 10 + 102 * 30, 3), testCase, "session OHLC and volume");
+        Expect(std::abs(snapshot.session_.GetVwap() - 101.4) < 1e-9, testCase, "session VWAP");
+
+        Expect(LevelVolume(snapshot, 100) == 10 && LevelVolume(snapshot, 101) == 10 && LevelVolume(snapshot, 102) == 30, testCase, "volume per price");
+        Expect(snapshot.untrackedVolume_ == 0, testCase, "no untracked volume");
+
+        const TradeAnalyticsSummary summary = *orderbook.GetTradeSummary();
+        Expect(summary.closedBarCount_ == 2 && summary.currentBar_.Empty(), testCase, "summary closed bar count");
+        Expect(SameBar(summary.lastBar_, 102, 102, 102, 102, 25, 102 * 25, 1), testCase, "summary last bar");
+        Expect(SameBar(summary.session_, 100, 102, 100, 102, 50, 100 * 10 + 101 * 10 + 102 * 30, 3), testCase, "summary session");
+    }
+
+    // Trades execute at the resting order's price, so an aggressive sell trades at the bids.
+    void TestRestingPrice()
+    {
+        const char* testCase = "resting price";
+        Orderbook orderbook{ BarSpecification::ByVolume(1000) };
+        Rest(orderbook, 1, Side::Buy, 99, 5);
+        Rest(orderbook, 2, Side::Buy, 98, 5);
+        Rest(orderbook, 3, Side::Sell, 90, 8);
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        Expect(SameBar(snapshot.currentBar_, 99, 99, 98, 98, 8, 99 * 5 + 98 * 3, 2), testCase, "bar priced at the bids");
+        Expect(LevelVolume(snapshot, 99) == 5 && LevelVolume(snapshot, 98) == 3 && LevelVolume(snapshot, 90) == 0, testCase, "volume per bid price");
+    }
+
+    // More completed bars than the ring holds: the oldest are dropped and the rest are reported oldest first.
+    void TestBarRing()
+    {
+        const char* testCase = "bar ring";
+        constexpr int Fills = static_cast<int>(TradeAnalyticsSnapshot::BarCapacity) + 6;
+
+        Orderbook orderbook{ BarSpecification::ByVolume(10) };
+        for (int fill = 0; fill < Fills; ++fill)
+        {
+            Rest(orderbook, 2 * fill + 1, Side::Sell, 1000 + fill, 10);
+            Rest(orderbook, 2 * fill + 2, Side::Buy, 1000 + fill, 10);
+        }
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        Expect(snapshot.barCount_ == TradeAnalyticsSnapshot::BarCapacity, testCase, "ring is full");
+
+        bool ordered = true;
+        for (std::size_t bar = 0; bar < snapshot.barCount_; ++bar)
+            ordered &= snapshot.bars_[bar].close_ == static_cast<Price>(1000 + Fills - TradeAnalyticsSnapshot::BarCapacity + bar);
+        Expect(ordered, testCase, "bars unrolled oldest first");
+
+        Expect(orderbook.GetTradeSummary()->closedBarCount_ == static_cast<std::uint64_t>(Fills), testCase, "summary counts every closed bar");
+    }
+
+    // Time bars open at a multiple of their interval, and a bar still inside its interval stays current.
+    void TestTimeBarAlignment()
+    {
+        const char* testCase = "time bar alignment";
+        const auto interval = std::chrono::hours(1);
+
+        Orderbook orderbook{ BarSpecification::ByTime(interval) };
+        const auto before = std::chrono::system_clock::now();
+        Rest(orderbook, 1, Side::Sell, 100, 10);
+        Rest(orderbook, 2, Side::Buy, 100, 10);
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        const auto openTime = snapshot.currentBar_.openTime_;
+        Expect(snapshot.barCount_ == 0 && snapshot.currentBar_.volume_ == 10, testCase, "trade in the current bar");
+        Expect(openTime.time_since_epoch() % interval == std::chrono::system_clock::duration::zero(), testCase, "bar opens on the interval");
+        Expect(openTime <= before && before - openTime < interval, testCase, "bar opens at the start of the trade's interval");
+    }
+
+    // A time bar whose interval has passed is reported as closed, before and after the ring is full.
+    void TestExpiredTimeBar()
+    {
+        const char* testCase = "expired time bar";
+        const auto interval = std::chrono::milliseconds(20);
+
+        Orderbook orderbook{ BarSpecification::ByTime(interval) };
+        Rest(orderbook, 1, Side::Sell, 100, 10);
+        Rest(orderbook, 2, Side::Buy, 100, 10);
+        std::this_thread::sleep_for(2 * interval);
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        Expect(snapshot.barCount_ == 1 && snapshot.currentBar_.Empty(), testCase, "snapshot reports the bar as closed");
+        Expect(SameBar(snapshot.bars_[0], 100, 100, 100, 100, 10, 1000, 1), testCase, "snapshot closed bar");
+
+        const TradeAnalyticsSummary summary = *orderbook.GetTradeSummary();
+        Expect(summary.closedBarCount_ == 1 && summary.currentBar_.Empty(), testCase, "summary reports the bar as closed");
+        Expect(SameBar(summary.lastBar_, 100, 100, 100, 100, 10, 1000, 1), testCase, "summary last bar");
+
+        // The next trade really closes it, and opens a new current bar.
+        Rest(orderbook, 3, Side::Sell, 101, 5);
+        Rest(orderbook, 4, Side::Buy, 101, 5);
+        const TradeAnalyticsSnapshot next = *orderbook.GetTradeAnalytics();
+        Expect(next.barCount_ == 1 && next.currentBar_.volume_ == 5 && next.bars_[0].volume_ == 10, testCase, "next trade closes the bar once");
+    }
+
+    void TestExpiredTimeBarFullRing()
+    {
+        const char* testCase = "expired time bar, full ring";
+        const auto interval = std::chrono::milliseconds(1);
+        constexpr int Fills = static_cast<int>(TradeAnalyticsSnapshot::BarCapacity) + 2;
+
+        Orderbook orderbook{ BarSpecification::ByTime(interval) };
+        for (int fill = 0; fill < Fills; ++fill)
+        {
+            Rest(orderbook, 2 * fill + 1, Side::Sell, 1000 + fill, 10);
+            Rest(orderbook, 2 * fill + 2, Side::Buy, 1000 + fill, 10);
+            std::this_thread::sleep_for(2 * interval);
+        }
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        Expect(snapshot.barCount_ == TradeAnalyticsSnapshot::BarCapacity && snapshot.currentBar_.Empty(), testCase, "ring full, no current bar");
+
+        bool ordered = true;
+        for (std::size_t bar = 0; bar < snapshot.barCount_; ++bar)
+            ordered &= snapshot.bars_[bar].close_ == static_cast<Price>(1000 + Fills - TradeAnalyticsSnapshot::BarCapacity + bar);
+        Expect(ordered, testCase, "expired bar is the newest, oldest dropped");
+    }
+
+    // Prices a multiple of the table size apart must not all land in the same probe run.
+    void TestLevelTable()
+    {
+        const char* testCase = "level table";
+        constexpr int Prices = 32;
+
+        Orderbook orderbook{ BarSpecification::ByVolume(1000) };
+        for (int i = 0; i < Prices; ++i)
+        {
+            const Price price = 1000 + i * static_cast<Price>(TradeAnalyticsSnapshot::LevelCapacity);
+            Rest(orderbook, 2 * i + 1, Side::Sell, price, 10);
+            Rest(orderbook, 2 * i + 2, Side::Buy, price, 10);
+        }
+
+        const TradeAnalyticsSnapshot snapshot = *orderbook.GetTradeAnalytics();
+        bool tracked = true;
+        for (int i = 0; i < Prices; ++i)
+            tracked &= LevelVolume(snapshot, 1000 + i * static_cast<Price>(TradeAnalyticsSnapshot::LevelCapacity)) == 10;
+
+        Expect(tracked && snapshot.untrackedVolume_ == 0, testCase, "prices a table size apart are all tracked");
+    }
+
+    void TestInvalidSpecification()
+    {
+        const char* testCase = "invalid specification";
+
+        bool threw = false;
+        try { TradeAnalytics analytics{ BarSpecification::ByTime(std::chrono::nanoseconds(0)) }; }
+        catch (const std::logic_error&) { threw = true; }
+        Expect(threw, testCase, "zero interval throws");
+
+        threw = false;
+        try { TradeAnalytics analytics{ BarSpecification::ByVolume(0) }; }
+        catch (const std::logic_error&) { threw = true; }
+        Expect(threw, testCase, "zero volume throws");
+
+        Orderbook orderbook;
+        Expect(!orderbook.GetTradeAnalytics() && !orderbook.GetTradeSummary(), testCase, "no analytics without a bar specification");
+    }
+}
+
+int main()
+{
+    TestVolumeBars();
+    TestRestingPrice();
+    TestBarRing();
+    TestTimeBarAlignment();
+    TestExpiredTimeBar();
+    TestExpiredTimeBarFullRing();
+    TestLevelTable();
+    TestInvalidSpecification();
+
+    std::cout << checks << " checks, " << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include "Usings.h"
+
+// Open, high, low, close and volume of the trades executed over one bar (or the whole session).
+struct TradeBar
+{
+    std::chrono::system_clock::time_point openTime_{};
+    Price open_{};
+    Price high_{};
+    Price low_{};
+    Price close_{};
+    std::uint64_t volume_{};
+    std::int64_t notional_{};
+    std::uint32_t tradeCount_{};
+
+    bool Empty() const { return tradeCount_ == 0; }
+    double GetVwap() const { return volume_ == 0 ? 0.0 : static_cast<double>(notional_) / static_cast<double>(volume_); }
+
+    void Add(std::chrono::system_clock::time_point time, Price price, Quantity quantity)
+    {
+        if (Empty())
+        {
+            openTime_ = time;
+            open_ = high_ = low_ = price;
+        }
+
+        high_ = std::max(high_, price);
+        low_ = std::min(low_, price);
+        close_ = price;
+        volume_ += quantity;
+        notional_ += static_cast<std::int64_t>(price) * quantity;
+        ++tradeCount_;
+    }
+};
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <random>
+#include <limits>
+#include <optional>
+#include <unordered_set>
+
+#include "BatchValidator.h"
+
+/*
+Randomized parity test of the batch validation kernels.
+
+Every kernel the running CPU supports is checked against Reference, a plain 64 bit restatement of the rules documented on BatchValidator
+that shares no code with the kernels. Batches cover every tail length 0 to 7 past the vector loops, and the draws deliberately include
+negative and extreme prices, quantities at and above 2^31, and zero or negative notional limits.
+
+Every round also draws the batch's ids from one of several patterns (a small random range, the same range scrambled over 64 bits,
+all equal, sequential, and sequences that differ only in their high bits or sit at the top of the id range). Batches of 512 and 4096
+orders, in every tenth round, load the duplicate table with enough distinct ids for long probe runs that wrap past its last slot.
+In every fourth round the limits are wide open and every order is valid, so duplicates are the only reason to reject an order.
+*/
+
+namespace
+{
+    constexpr Price PriceMin = std::numeric_limits<Price>::min();
+    constexpr Price PriceMax = std::numeric_limits<Price>::max();
+    constexpr Quantity QuantityMax = std::numeric_limits<Quantity>::max();
+    constexpr std::int64_t NotionalMax = std::numeric_limits<std::int64_t>::max();
+
+    AcceptMask Reference(const RiskLimits& limits, const OrderBatch& batch, std::optional<Price> bestBid, std::optional<Price> bestAsk)
+    {
+        AcceptMask accept(batch.Size());
+        for (std::size_t i = 0; i < batch.Size(); ++i)
+        {
+            const Side side = batch.GetSides()[i];
+            const std::int64_t price = batch.GetPrices()[i];
+            const std::int64_t quantity = batch.GetQuantities()[i];
+
+            const std::optional<Price> reference = side == Side::Buy ? (bestAsk ? bestAsk : bestBid) : (bestBid ? bestBid : bestAsk);
+            const bool inCollar = !reference || (price >= std::int64_t{ *reference } - limits.priceCollar_ && price <= std::int64_t{ *reference } + limits.priceCollar_);
+
+            // A positive int32 times a uint32 stays below 2^63.
+            accept[i] = price > 0 && inCollar &&
+                quantity > 0 && quantity <= std::int64_t{ limits.maxQuantity_ } &&
+                price * quantity <= limits.maxNotional_;
+        }
+
+        std::unordered_set<OrderId> seen;
+        for (std::size_t i = 0; i < batch.Size(); ++i)
+        {
+            if (!seen.insert(batch.GetOrderIds()[i]).second)
+                accept[i] = 0;
+        }
+
+        return accept;
+    }
+
+    template <typename T>
+    T Pick(std::mt19937_64& random, std::initializer_list<T> values)
+    {
+        return values.begin()[random() % values.size()];
+    }
+
+    Price MakePrice(std::mt19937_64& random)
+    {
+        switch (random() % 4)
+        {
+        case 0:
+            return Pick<Price>(random, { 0, -1, 1, -100, PriceMin, PriceMin + 1, PriceMax, PriceMax - 1 });
+        case 1:
+            return static_cast<Price>(random());
+        default:
+            return static_cast<Price>(90 + random() % 25) * (random() % 8 == 0 ? -1 : 1);
+        }
+    }
+
+    Quantity MakeQuantity(std::mt19937_64& random)
+    {
+        switch (random() % 4)
+        {
+        case 0:
+            return Pick<Quantity>(random, { 0, 1, 1u << 31, (1u << 31) - 1, (1u << 31) + 1, QuantityMax, QuantityMax - 1 });
+        case 1:
+            return (1u << 31) + static_cast<Quantity>(random() % (1u << 31));
+        default:
+            return static_cast<Quantity>(random() % 1500);
+        }
+    }
+
+    enum class IdPattern
+    {
+        Random,
+        Scrambled,
+        AllEqual,
+        Sequential,
+        HighBits,
+        TopOfRange,
+        Count,
+    };
+
+    // idRange bounds the Random and Scrambled patterns: mostly distinct ids for a large range, many duplicates for a small one.
+    OrderId MakeOrderId(std::mt19937_64& random, IdPattern pattern, std::size_t index, OrderId idRange)
+    {
+        switch (pattern)
+        {
+        case IdPattern::AllEqual:
+            return 7;
+        case IdPattern::Sequential:
+            return index + 1;
+        case IdPattern::HighBits:
+            return static_cast<OrderId>(index) << 40;
+        case IdPattern::TopOfRange:
+            return std::numeric_limits<OrderId>::max() - index;
+        case IdPattern::Scrambled:
+        {
+            // The splitmix64 finaliser keeps duplicates but spreads the ids over 64 bits. Small or regular ids hash almost perfectly
+            // evenly, so these are what make long probe runs, and runs wrapping past the last slot, in the duplicate table.
+            OrderId id = random() % idRange + 0x9E3779B97F4A7C15ull;
+            id = (id ^ (id >> 30)) * 0xBF58476D1CE4E5B9ull;
+            id = (id ^ (id >> 27)) * 0x94D049BB133111EBull;
+            return id ^ (id >> 31);
+        }
+        default:
+            return random() % idRange;
+        }
+    }
+
+    RiskLimits MakeLimits(std::mt19937_64& random)
+    {
+        const Price priceCollar = Pick<Price>(random, { 0, 5, 20, 1 << 20, PriceMax });
+        const Quantity maxQuantity = Pick<Quantity>(random, { 0, 1000, (1u << 31) - 1, 1u << 31, QuantityMax });
+        const std::int64_t maxNotional = random() % 2
+            ? Pick<std::int64_t>(random, { -1, 0, std::numeric_limits<std::int64_t>::min(), -100000, NotionalMax, std::int64_t{ 1 } << 32 })
+            : static_cast<std::int64_t>(random() % 400000) - 200000;
+
+        return RiskLimits{ priceCollar, maxQuantity, maxNotional };
+    }
+
+    std::optional<Price> MakeBest(std::mt19937_64& random)
+    {
+        if (random() % 4 == 0)
+            return std::nullopt;
+
+        return random() % 8 == 0 ? Pick<Price>(random, { -100, 0, PriceMin, PriceMax }) : static_cast<Price>(95 + random() % 10);
+    }
+}
+
+int main()
+{
+    constexpr int Rounds = 2000;
+    const ValidationKernel kernels[] = { ValidationKernel::Scalar, ValidationKernel::Sse, ValidationKernel::Avx2 };
+    const char* names[] = { "scalar", "sse4.2", "avx2" };
+
+    std::mt19937_64 random{ 20240611 };
+    std::size_t batches = 0;
+    std::size_t failures = 0;
+
+    for (int round = 0; round < Rounds; ++round)
+    {
+        // Every fourth round only duplicates can reject an order, so a wrong duplicate verdict is never hidden by a failed field check.
+        const bool duplicatesOnly = round % 4 == 0;
+        const RiskLimits limits = duplicatesOnly ? RiskLimits{ PriceMax, QuantityMax, NotionalMax } : MakeLimits(random);
+        const std::optional<Price> bestBid = MakeBest(random);
+        const std::optional<Price> bestAsk = MakeBest(random);
+
+        const IdPattern pattern = static_cast<IdPattern>(random() % static_cast<std::size_t>(IdPattern::Count));
+
+        // Full vectors of every width, followed by each possible tail.
+        for (std::size_t body : { 0, 8, 16, 64, 512, 4096 })
+        {
+            if (body >= 512 && round % 10 != 0)
+                continue;
+
+            for (std::size_t tail = 0; tail < 8; ++tail)
+            {
+                OrderBatch batch;
+                const std::size_t size = body + tail;
+                const OrderId idRange = 1 + random() % (2 * size + 1);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    const Price price = duplicatesOnly ? static_cast<Price>(1 + random() % 1000) : MakePrice(random);
+                    const Quantity quantity = duplicatesOnly ? static_cast<Quantity>(1 + random() % 1000) : MakeQuantity(random);
+                    batch.Add(MakeOrderId(random, pattern, i, idRange), random() % 2 ? Side::Buy : Side::Sell, price, quantity);
+                }
+
+                const AcceptMask expected = Reference(limits, batch, bestBid, bestAsk);
+                ++batches;
+
+                for (std::size_t k = 0; k < std::size(kernels); ++k)
+                {
+                    if (!BatchValidator::IsSupported(kernels[k]))
+                        continue;
+
+                    const AcceptMask actual = BatchValidator{ limits, kernels[k] }.Validate(batch, bestBid, bestAsk);
+                    if (actual == expected)
+                        continue;
+
+                    if (failures++ < 10)
+                    {
+                        std::size_t i = 0;
+                        while (actual[i] == expected[i])
+                            ++i;
+
+                        std::cout << "MISMATCH " << names[k] << " size " << size << " order " << i
+                            << ": id " << batch.GetOrderIds()[i] << (batch.GetSides()[i] == Side::Buy ? " buy " : " sell ")
+                            << batch.GetPrices()[i] << " x " << batch.GetQuantities()[i]
+                            << ", collar " << limits.priceCollar_ << " max quantity " << limits.maxQuantity_ << " max notional " << limits.maxNotional_
+                            << ", expected " << int{ expected[i] } << " got " << int{ actual[i] } << '\n';
+                    }
+                }
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < std::size(kernels); ++k)
+        std::cout << names[k] << (BatchValidator::IsSupported(kernels[k]) ? ": checked" : ": not supported, skipped") << '\n';
+
+    std::cout << batches << " batches, " << failures << " mismatches\n";
+    return failures == 0 ? 0 : 1;
+}